@@ -8,6 +8,15 @@
 // provides isa<T>
 #include "clang/AST/DeclBase.h"
 #include "clang/AST/ExprCXX.h"
+#include "clang/AST/ASTContext.h"
+#include "clang/AST/RecursiveASTVisitor.h"
+#include "clang/Lex/Lexer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace dextool_clang_extension {
 
@@ -673,4 +682,286 @@ ValueKind dex_getExprValueKind(const CXCursor cx_expr) {
     return ValueKind::unknown;
 }
 
+struct DXLocation {
+    uint32_t offset;
+    uint32_t line;
+    uint32_t column;
+};
+
+/// An operator expression with the data that the mutation analyzer use.
+struct DXOperatorNode {
+    /// The clang::Stmt of the expression. Same as data[1] of its cursor.
+    const void* stmt;
+
+    OpKind kind;
+    bool isOverload;
+
+    /// Index in DXOperatorIndex.files of the file of the cursor location.
+    uint32_t file;
+    /// The spelling location of the extent of the expression.
+    DXLocation exprBegin;
+    DXLocation exprEnd;
+    /// The spelling location of the operator.
+    DXLocation op;
+    /// Character length of the operator.
+    uint32_t opLength;
+
+    /// The underlying expressions of the sides. rhs is null for unary operators.
+    CXCursor lhs;
+    CXCursor rhs;
+};
+
+/// The operator expressions of a translation unit sorted by `stmt`.
+struct DXOperatorIndex {
+    DXOperatorNode* nodes;
+    size_t length;
+
+    /// The path of the files that the nodes refer to.
+    const char* const* files;
+    size_t filesLength;
+
+    /// Owns the memory of the index.
+    void* storage;
+};
+
+namespace {
+
+struct OperatorIndexStorage {
+    std::vector<DXOperatorNode> nodes;
+    std::vector<std::string> files;
+    std::vector<const char*> fileNames;
+};
+
+/// Collect the operator expressions by walking the AST once.
+///
+/// The data is derived from the clang AST and the source manager in the same
+/// way as libclang do it for a cursor, without going via the C API.
+class OperatorCollector : public clang::RecursiveASTVisitor<OperatorCollector> {
+    using Base = clang::RecursiveASTVisitor<OperatorCollector>;
+
+public:
+    OperatorCollector(const clang::ASTContext& ctx, CXTranslationUnit tu, OperatorIndexStorage& dst)
+        : sm(ctx.getSourceManager()), lang(ctx.getLangOpts()), tu(tu), dst(dst) {}
+
+    bool TraverseDecl(clang::Decl* decl) {
+        // the analyzer never mutate system headers thus the declarations in
+        // them, which often are most of the AST, are not walked.
+        if (decl != nullptr && !llvm::isa<clang::TranslationUnitDecl>(decl) &&
+            sm.isInSystemHeader(decl->getLocation())) {
+            return true;
+        }
+
+        // libclang use the closest declaration as the parent of a statement.
+        parents.push_back(decl);
+        const bool rval = Base::TraverseDecl(decl);
+        parents.pop_back();
+        return rval;
+    }
+
+    bool VisitBinaryOperator(clang::BinaryOperator* expr) {
+        DXOperator op;
+        if (toOpKind(expr->getOpcode(), op)) {
+            add(expr, op, expr->getOperatorLoc(), expr->getLHS(), expr->getRHS());
+        }
+        return true;
+    }
+
+    bool VisitUnaryOperator(clang::UnaryOperator* expr) {
+        DXOperator op;
+        if (toOpKind(expr->getOpcode(), op)) {
+            add(expr, op, expr->getOperatorLoc(), expr->getSubExpr(), nullptr);
+        }
+        return true;
+    }
+
+    bool VisitCXXOperatorCallExpr(clang::CXXOperatorCallExpr* expr) {
+        DXOperator op;
+        if (!toOpKind(expr->getOperator(), op)) {
+            return true;
+        }
+
+        // See: dex_getOperatorExprs
+        const clang::Expr* lhs = nullptr;
+        const clang::Expr* rhs = nullptr;
+        if (expr->getNumArgs() == 1) {
+            lhs = expr->getArg(0);
+        } else if (expr->getNumArgs() == 2) {
+            lhs = expr->getArg(0);
+            rhs = expr->getArg(1);
+        }
+        add(expr, op, expr->getOperatorLoc(), lhs, rhs);
+        return true;
+    }
+
+private:
+    void add(const clang::Expr* expr, const DXOperator& op, clang::SourceLocation opLoc,
+             const clang::Expr* lhs, const clang::Expr* rhs);
+
+    /// The spelling location of `loc`. See: clang_getSpellingLocation.
+    DXLocation toSpelling(clang::SourceLocation loc, clang::FileID* file = nullptr) const;
+
+    /// The end of the token at `loc`. See: translateSourceRange in CIndex.cpp.
+    clang::SourceLocation endOfToken(clang::SourceLocation loc) const;
+
+    /// Returns the index of `file` in the storage.
+    uint32_t fileIndex(clang::FileID file);
+
+    /// See: dex_getUnderlyingExprNode
+    CXCursor underlying(const clang::Expr* expr) const;
+
+    const clang::SourceManager& sm;
+    const clang::LangOptions& lang;
+    CXTranslationUnit tu;
+    OperatorIndexStorage& dst;
+    std::vector<const clang::Decl*> parents;
+    std::unordered_map<unsigned, uint32_t> files;
+};
+
+DXLocation OperatorCollector::toSpelling(clang::SourceLocation loc, clang::FileID* file) const {
+    DXLocation rval{0, 0, 0};
+    if (loc.isInvalid()) {
+        return rval;
+    }
+
+    const std::pair<clang::FileID, unsigned> info = sm.getDecomposedLoc(sm.getSpellingLoc(loc));
+    if (info.first.isInvalid()) {
+        return rval;
+    }
+
+    if (file != nullptr) {
+        *file = info.first;
+    }
+    rval.offset = info.second;
+    rval.line = sm.getLineNumber(info.first, info.second);
+    rval.column = sm.getColumnNumber(info.first, info.second);
+    return rval;
+}
+
+clang::SourceLocation OperatorCollector::endOfToken(clang::SourceLocation loc) const {
+    bool isTokenRange = true;
+    if (loc.isValid() && loc.isMacroID() && !sm.isMacroArgExpansion(loc)) {
+        const clang::CharSourceRange expansion = sm.getExpansionRange(loc);
+        loc = expansion.getEnd();
+        isTokenRange = expansion.isTokenRange();
+    }
+    if (isTokenRange && loc.isValid()) {
+        loc = loc.getLocWithOffset(
+            clang::Lexer::MeasureTokenLength(sm.getSpellingLoc(loc), sm, lang));
+    }
+    return loc;
+}
+
+uint32_t OperatorCollector::fileIndex(clang::FileID file) {
+    auto it = files.find(file.getHashValue());
+    if (it != files.end()) {
+        return it->second;
+    }
+
+    const clang::FileEntry* entry = sm.getFileEntryForID(file);
+    const uint32_t rval = static_cast<uint32_t>(dst.files.size());
+    dst.files.push_back(entry == nullptr ? std::string() : entry->getName().str());
+    files.emplace(file.getHashValue(), rval);
+    return rval;
+}
+
+CXCursor OperatorCollector::underlying(const clang::Expr* expr) const {
+    expr = getUnderlyingExprNode(expr);
+    if (expr == nullptr) {
+        return clang_getNullCursor();
+    }
+    return clang::cxcursor::dex_MakeCXCursor(expr, parents.back(), tu, expr->getSourceRange());
+}
+
+void OperatorCollector::add(const clang::Expr* expr, const DXOperator& op,
+                            clang::SourceLocation opLoc, const clang::Expr* lhs,
+                            const clang::Expr* rhs) {
+    if (parents.empty() || parents.back() == nullptr || sm.isInSystemHeader(expr->getExprLoc())) {
+        return;
+    }
+
+    DXOperatorNode n;
+    n.stmt = expr;
+    n.kind = op.kind;
+    n.isOverload = llvm::isa<clang::CXXOperatorCallExpr>(expr);
+
+    // the location of an expression cursor is the beginning of it.
+    clang::FileID file;
+    toSpelling(expr->getBeginLoc(), &file);
+    if (file.isInvalid()) {
+        return;
+    }
+    n.file = fileIndex(file);
+
+    const clang::SourceRange extent = expr->getSourceRange();
+    n.exprBegin = toSpelling(extent.getBegin());
+    n.exprEnd = toSpelling(endOfToken(extent.getEnd()));
+    n.op = toSpelling(opLoc);
+
+    // See: Operator.length in the D code.
+    n.opLength = op.opLength;
+    if (rhs == nullptr) {
+        const DXLocation l = lhs == nullptr ? DXLocation{0, 0, 0} : toSpelling(lhs->getBeginLoc());
+        n.opLength = n.op.offset > l.offset ? n.op.offset - l.offset : l.offset - n.op.offset;
+    } else {
+        const DXLocation r = toSpelling(rhs->getBeginLoc());
+        if (r.offset > n.op.offset) {
+            n.opLength = r.offset - n.op.offset;
+        }
+    }
+
+    n.lhs = underlying(lhs);
+    n.rhs = underlying(rhs);
+
+    dst.nodes.push_back(n);
+}
+
+} // namespace
+
+/** Extract the operator expressions of the translation unit `root` is in.
+ *
+ * The AST, except the declarations in system headers, is walked once natively
+ * instead of deriving the data from each cursor via the C API.
+ *
+ * The result must be released with dex_disposeOperatorIndex.
+ */
+DXOperatorIndex dex_getOperatorIndex(const CXCursor root) {
+    DXOperatorIndex rval{nullptr, 0, nullptr, 0, nullptr};
+
+    CXTranslationUnit tu = getCursorTU(root);
+    if (tu == nullptr || getCursorASTUnit(root) == nullptr) {
+        return rval;
+    }
+    clang::ASTContext* ctx = getCursorContext(root);
+
+    auto storage = new OperatorIndexStorage;
+    OperatorCollector collector(*ctx, tu, *storage);
+    collector.TraverseDecl(ctx->getTranslationUnitDecl());
+
+    auto& nodes = storage->nodes;
+    std::sort(nodes.begin(), nodes.end(), [](const DXOperatorNode& a, const DXOperatorNode& b) {
+        return std::less<const void*>()(a.stmt, b.stmt);
+    });
+    // a node can be visited more than once, e.g. via a lambda
+    nodes.erase(std::unique(nodes.begin(), nodes.end(),
+                            [](const DXOperatorNode& a, const DXOperatorNode& b) {
+                                return a.stmt == b.stmt;
+                            }),
+                nodes.end());
+
+    for (const auto& f : storage->files) {
+        storage->fileNames.push_back(f.c_str());
+    }
+
+    rval.nodes = nodes.data();
+    rval.length = nodes.size();
+    rval.files = storage->fileNames.data();
+    rval.filesLength = storage->fileNames.size();
+    rval.storage = storage;
+    return rval;
+}
+
+void dex_disposeOperatorIndex(DXOperatorIndex index) {
+    delete static_cast<OperatorIndexStorage*>(index.storage);
+}
+
 } // namespace dextool_clang_extension
@@ -58,9 +58,6 @@ CXCursor dex_MakeCXCursor(const clang::Stmt* S, const clang::Decl* Parent, CXTra
 CXCursor dex_MakeCursorVariableRef(const clang::VarDecl* Var, clang::SourceLocation Loc,
                                    CXTranslationUnit TU);
 
-/// Returns the underlying node that is not an reference or implicit cast.
-const clang::Expr* getUnderlyingExprNode(const clang::Expr* expr);
-
 /// Returns a Cursor for the underlying node that is not an reference or implicit cast.
 CXCursor dex_getUnderlyingExprNode(const CXCursor cx_expr);
 
@@ -92,6 +89,12 @@ const clang::Stmt* getCursorStmt(CXCursor Cursor);
 // See: CIndex.cpp
 CXSourceLocation getLocation(CXCursor C);
 
+/// Returns the underlying node that is not an reference or implicit cast.
+const clang::Expr* getUnderlyingExprNode(const clang::Expr* expr);
+
+/// Returns a Cursor for the underlying node that is not an reference or implicit cast.
+CXCursor dex_getUnderlyingExprNode(const CXCursor cx_expr);
+
 // See: CXSourceLocation.h
 /// Translate a Clang source location into a CIndex source location.
 CXSourceLocation translateSourceLocation(clang::ASTContext& Context, clang::SourceLocation Loc);
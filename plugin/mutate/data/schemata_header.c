@@ -1,37 +1,183 @@
-
 #ifndef DEXTOOL_MUTANT_SCHEMATA_INCL_GUARD
 #pragma GCC diagnostic ignored "-Wunused-macros"
 #define DEXTOOL_MUTANT_SCHEMATA_INCL_GUARD
 #include <stdlib.h>
 
+#ifndef DEXTOOL_NO_FORKSRV
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #ifdef DEXTOOL_STRONG_ATTR
 #define DEXTOOL_ATTR
 #else
 #define DEXTOOL_ATTR __attribute__((weak))
 #endif
 
-static unsigned int gDEXTOOL_MUTID_ISINIT = 0;
-static unsigned int gDEXTOOL_MUTID = 0;
+/* Shared by all files with a schema. The weak definitions are merged to one
+ * by the linker. */
+DEXTOOL_ATTR unsigned int gDEXTOOL_MUTID_ISINIT = 0;
+DEXTOOL_ATTR unsigned int gDEXTOOL_MUTID = 0;
+
+static unsigned int dextool_parse_mutid(const char* c) {
+    unsigned int id = 0;
+    for (; *c != '\0'; ++c) {
+        const unsigned int n = *c - '0';
+        if (n > 9) {
+            return 0;
+        }
+        id = id * 10u + n;
+    }
+    return id;
+}
+
+#ifndef DEXTOOL_NO_FORKSRV
+/* Message sent by the fork server when it is ready to receive mutant IDs. */
+#define DEXTOOL_FORKSRV_HELLO 0x44584653u
+
+/* Read/write exactly 4 bytes. Returns 1 on success. */
+static int dextool_forksrv_read(int fd, unsigned int* v) {
+    char* p = (char*)v;
+    size_t left = sizeof(*v);
+    while (left > 0) {
+        const ssize_t r = read(fd, p, left);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return 0;
+        p += r;
+        left -= (size_t)r;
+    }
+    return 1;
+}
+
+static int dextool_forksrv_write(int fd, unsigned int v) {
+    const char* p = (const char*)&v;
+    size_t left = sizeof(v);
+    while (left > 0) {
+        const ssize_t r = write(fd, p, left);
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r <= 0)
+            return 0;
+        p += r;
+        left -= (size_t)r;
+    }
+    return 1;
+}
+
+/* Fork server, activated by the env variables DEXTOOL_FORKSRV_CTRL and
+ * DEXTOOL_FORKSRV_STATUS which are the paths to two named pipes.
+ *
+ * The process that first reach this point becomes the server. Everything up
+ * to here, static initialization and test fixtures, has been executed without
+ * touching a mutant thus it is the same for all mutants.
+ *
+ * Protocol, all messages are 4 bytes in native byte order:
+ *  server -> dextool: DEXTOOL_FORKSRV_HELLO
+ *  loop:
+ *   dextool -> server: mutant ID
+ *   server -> dextool: pid of the child executing the mutant
+ *   server -> dextool: the raw status from waitpid of the child
+ *
+ * The child is the leader of its own process group. It makes it possible to
+ * kill the processes that the test started, e.g. death tests, together with
+ * the child.
+ *
+ * Returns: 1 in the forked child that should execute the mutant, 0 if the fork
+ * server is not active. The server itself never returns.
+ */
+static int dextool_forksrv(void) {
+    const char* ctrl_path = getenv("DEXTOOL_FORKSRV_CTRL");
+    const char* status_path = getenv("DEXTOOL_FORKSRV_STATUS");
+    int ctrl_fd;
+    int status_fd;
+
+    if (ctrl_path == NULL || status_path == NULL)
+        return 0;
+
+    ctrl_fd = open(ctrl_path, O_RDONLY);
+    if (ctrl_fd == -1)
+        return 0;
+    status_fd = open(status_path, O_WRONLY);
+    if (status_fd == -1) {
+        close(ctrl_fd);
+        return 0;
+    }
+
+    if (!dextool_forksrv_write(status_fd, DEXTOOL_FORKSRV_HELLO)) {
+        close(ctrl_fd);
+        close(status_fd);
+        return 0;
+    }
+
+    for (;;) {
+        unsigned int id;
+        pid_t child;
+        int status;
+
+        /* dextool closed the pipe, no more mutants to test. */
+        if (!dextool_forksrv_read(ctrl_fd, &id))
+            _exit(0);
+
+        child = fork();
+        if (child < 0)
+            _exit(1);
+
+        if (child == 0) {
+            char buf[16];
+
+            setpgid(0, 0);
+            close(ctrl_fd);
+            close(status_fd);
+            unsetenv("DEXTOOL_FORKSRV_CTRL");
+            unsetenv("DEXTOOL_FORKSRV_STATUS");
+            /* propagate the mutant to sub-processes started by the test. */
+            snprintf(buf, sizeof(buf), "%u", id);
+            setenv("DEXTOOL_MUTID", buf, 1);
+
+            gDEXTOOL_MUTID = id;
+            return 1;
+        }
+
+        /* both set the group to avoid a race with dextool killing it. */
+        setpgid(child, child);
+        if (!dextool_forksrv_write(status_fd, (unsigned int)child))
+            _exit(1);
+        while (waitpid(child, &status, 0) < 0) {
+            if (errno != EINTR)
+                _exit(1);
+        }
+        /* processes left by the test could keep the output pipes open. */
+        kill(-child, SIGKILL);
+        if (!dextool_forksrv_write(status_fd, (unsigned int)status))
+            _exit(1);
+    }
+}
+#endif
 
 DEXTOOL_ATTR void dextool_init_mutid(void) {
     const char* c;
 
+#ifndef DEXTOOL_NO_FORKSRV
+    if (dextool_forksrv()) {
+        gDEXTOOL_MUTID_ISINIT = 1;
+        return;
+    }
+#endif
+
     c = getenv("DEXTOOL_MUTID");
     if (c == NULL) {
         gDEXTOOL_MUTID_ISINIT = 1;
         return;
     }
 
-    unsigned int id = 0;
-    for (; *c != '\0'; ++c) {
-        const unsigned int n = *c - '0';
-        if (n > 9) {
-            id = 0;
-            break;
-        }
-        id = id * 10u + n;
-    }
-    gDEXTOOL_MUTID = id;
+    gDEXTOOL_MUTID = dextool_parse_mutid(c);
     gDEXTOOL_MUTID_ISINIT = 1;
 }
 
@@ -42,5 +188,17 @@ DEXTOOL_ATTR unsigned int dextool_get_mutid(void) {
     return gDEXTOOL_MUTID;
 }
 
-#endif /* DEXTOOL_MUTANT_SCHEMATA_INCL_GUARD */
+/* Initialize the ID before main so reading it is only a read of a global. The
+ * fork server is excluded because it should be started as late as possible,
+ * at the first read, for the static initialization to be shared by all
+ * mutants. */
+__attribute__((constructor)) static void dextool_init_mutid_ctor(void) {
+#ifndef DEXTOOL_NO_FORKSRV
+    if (getenv("DEXTOOL_FORKSRV_CTRL") != NULL)
+        return;
+#endif
+    if (gDEXTOOL_MUTID_ISINIT == 0)
+        dextool_init_mutid();
+}
 
+#endif /* DEXTOOL_MUTANT_SCHEMATA_INCL_GUARD */
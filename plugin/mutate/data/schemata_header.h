@@ -6,6 +6,9 @@
 extern void dextool_init_mutid(void);
 extern unsigned int dextool_get_mutid(void);
 
+extern unsigned int gDEXTOOL_MUTID_ISINIT;
+extern unsigned int gDEXTOOL_MUTID;
+
 #ifndef unlikely
 /* __builtin_expect added in gcc >4.0 */
 #if (__GNUC__ > 4)
@@ -15,4 +18,14 @@ extern unsigned int dextool_get_mutid(void);
 #endif
 #endif
 
+/* The schemas read the mutant ID via this function. It is inlined to a read
+ * of a global because the ID is initialized by a constructor before main. The
+ * out-of-line call is only taken the first time when the fork server is
+ * active because it is started at the first read of the ID. */
+static __inline__ unsigned int dextool_read_mutid(void) {
+    if (unlikely(gDEXTOOL_MUTID_ISINIT == 0))
+        return dextool_get_mutid();
+    return gDEXTOOL_MUTID;
+}
+
 #endif /* DEXTOOL_MUTANT_SCHEMATA_HDR_INCL_GUARD */
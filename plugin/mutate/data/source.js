@@ -20,6 +20,8 @@ var g_active_locid = null;
 var g_loc_mutids = {};
 var g_filter_kinds = [];
 var g_filter_status = [];
+var g_muts_data = {};
+var g_testcase_info = {};
 
 var key_traverse_locs_up = 'ArrowUp';
 var key_traverse_locs_down = 'ArrowDown';
@@ -32,6 +34,7 @@ var key_toggle_show_coverage = 'Numpad1';
  * Initializes event listeners, data and intial state
  */
 function init() {
+    init_report_data();
     var current_mutant_selector = document.getElementById('current_mutant');
     current_mutant_selector.addEventListener('change',
         function (e) { current_mutant_onchange(e); });
@@ -83,6 +86,27 @@ function init() {
     document.body.focus();
 }
 
+/**
+ * Expands the compact data about the mutants and test cases, g_report_data,
+ * that is loaded from the side file of the report.
+ */
+function init_report_data() {
+    g_muts_data['-1'] = {'kind' : null, 'kindGroup' : null, 'status' : null, 'testCases' : null, 'orgText' : null, 'mutText' : null, 'meta' : null, 'size' : null};
+
+    var tc_names = [];
+    for (const [name, kills, link] of g_report_data.testCases) {
+        tc_names.push(name);
+        g_testcase_info[name] = {'kills': kills, 'link': link};
+    }
+
+    // [id, kind, kindGroup, status, testCases, orgText, mutText, meta, size]
+    for (const m of g_report_data.mutants) {
+        g_muts_data[m[0]] = {'kind' : m[1], 'kindGroup' : m[2], 'status' : m[3],
+            'testCases' : m[4] ? m[4].map(i => tc_names[i]) : null,
+            'orgText' : m[5], 'mutText' : m[6], 'meta' : m[7], 'size' : m[8]};
+    }
+}
+
 function priority_highlight_sort(mutids_array) {
     mutids_array.sort(highlight_compare);
     return mutids_array;
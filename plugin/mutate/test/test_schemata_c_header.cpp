@@ -9,6 +9,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #define start_test()                                                                               \
     do {                                                                                           \
@@ -19,6 +22,7 @@
         std::cout << __FILE__ << ":" << __LINE__ << " " << x << std::endl;                         \
     } while (0)
 
+#include "schemata_header.h"
 #include "schemata_header.c"
 
 const char* EnvKey = "DEXTOOL_MUTID";
@@ -41,6 +45,25 @@ void test_read_largest() {
     assert(dextool_get_mutid() == 4294967295);
 }
 
+void test_init_by_ctor() {
+    start_test();
+
+    msg("the constructor should have initialized the ID before main");
+    assert(gDEXTOOL_MUTID_ISINIT == 1);
+    assert(dextool_read_mutid() == 0);
+}
+
+void test_read_inline() {
+    start_test();
+
+    set_env_mutid(42);
+    dextool_init_mutid();
+
+    msg("the inlined read should be the same as the function");
+    assert(dextool_read_mutid() == 42);
+    assert(dextool_read_mutid() == dextool_get_mutid());
+}
+
 void test_init_once() {
     start_test();
 
@@ -55,10 +78,132 @@ void test_init_once() {
     assert(dextool_get_mutid() == prev);
 }
 
+static unsigned int read_msg(int fd) {
+    unsigned int v = 0;
+    char* p = (char*)&v;
+    size_t left = sizeof(v);
+    while (left > 0) {
+        const ssize_t r = read(fd, p, left);
+        // zero until the server has opened its end of the pipe
+        if (r == 0 || (r < 0 && errno == EAGAIN)) {
+            usleep(1000);
+            continue;
+        }
+        assert(r > 0);
+        p += r;
+        left -= (size_t)r;
+    }
+    return v;
+}
+
+// the process has terminated, a zombie is waiting to be reaped by init.
+static bool is_terminated(pid_t pid) {
+    if (kill(pid, 0) != 0)
+        return true;
+    char path[64];
+    sprintf(path, "/proc/%d/stat", (int)pid);
+    FILE* f = fopen(path, "r");
+    if (f == nullptr)
+        return true;
+    int p;
+    char comm[256];
+    char state = 0;
+    const int n = fscanf(f, "%d %255s %c", &p, comm, &state);
+    fclose(f);
+    return n == 3 && state == 'Z';
+}
+
+void test_fork_server() {
+    start_test();
+
+    char ctrl[] = "/tmp/dextool_forksrv_ctrl_XXXXXX";
+    char status[] = "/tmp/dextool_forksrv_status_XXXXXX";
+    assert(mkstemp(ctrl) != -1);
+    assert(mkstemp(status) != -1);
+    unlink(ctrl);
+    unlink(status);
+    assert(mkfifo(ctrl, 0600) == 0);
+    assert(mkfifo(status, 0600) == 0);
+
+    const int status_fd = open(status, O_RDONLY | O_NONBLOCK);
+    const int ctrl_fd = open(ctrl, O_RDWR);
+    assert(status_fd != -1 && ctrl_fd != -1);
+
+    // the mutant sends the pid of a process it started
+    int leak[2];
+    assert(pipe(leak) == 0);
+
+    const pid_t server = fork();
+    assert(server != -1);
+    if (server == 0) {
+        // dextool do not let the test process inherit its end of the pipes
+        close(status_fd);
+        close(ctrl_fd);
+        close(leak[0]);
+        setenv("DEXTOOL_FORKSRV_CTRL", ctrl, 1);
+        setenv("DEXTOOL_FORKSRV_STATUS", status, 1);
+        dextool_init_mutid();
+        // only the forked mutants reach this point
+        if (dextool_get_mutid() == 8) {
+            const pid_t grandchild = fork();
+            if (grandchild == 0) {
+                sleep(60);
+                _exit(0);
+            }
+            assert(write(leak[1], &grandchild, sizeof(grandchild)) == sizeof(grandchild));
+            _exit(8);
+        }
+        _exit(dextool_get_mutid() == 7 && getenv("DEXTOOL_FORKSRV_CTRL") == nullptr ? 7 : 1);
+    }
+
+    close(leak[1]);
+
+    msg("waiting for the handshake");
+    assert(read_msg(status_fd) == DEXTOOL_FORKSRV_HELLO);
+
+    const unsigned int id = 7;
+    assert(write(ctrl_fd, &id, sizeof(id)) == sizeof(id));
+    const unsigned int child = read_msg(status_fd);
+    const int child_status = (int)read_msg(status_fd);
+    msg("mutant executed by " << child << " with status " << child_status);
+    assert(child != 0 && (pid_t)child != server);
+    assert(WIFEXITED(child_status) && WEXITSTATUS(child_status) == 7);
+
+    msg("the processes started by a mutant are killed when it is done");
+    const unsigned int leak_id = 8;
+    assert(write(ctrl_fd, &leak_id, sizeof(leak_id)) == sizeof(leak_id));
+    pid_t grandchild = 0;
+    assert(read(leak[0], &grandchild, sizeof(grandchild)) == sizeof(grandchild));
+    read_msg(status_fd);
+    const int leak_status = (int)read_msg(status_fd);
+    assert(WIFEXITED(leak_status) && WEXITSTATUS(leak_status) == 8);
+    bool terminated = false;
+    for (int i = 0; i < 1000 && !terminated; ++i) {
+        terminated = is_terminated(grandchild);
+        if (!terminated)
+            usleep(1000);
+    }
+    assert(terminated);
+    close(leak[0]);
+
+    msg("closing the control pipe terminates the server");
+    close(ctrl_fd);
+    int server_status;
+    assert(waitpid(server, &server_status, 0) == server);
+    assert(WIFEXITED(server_status) && WEXITSTATUS(server_status) == 0);
+
+    close(status_fd);
+    unlink(ctrl);
+    unlink(status);
+}
+
 int main(int argc, char** argv) {
     assert(getenv(EnvKey) == nullptr);
 
+    test_init_by_ctor();
     test_read_largest();
+    test_read_inline();
     test_init_once();
+    test_fork_server();
     return 0;
 }